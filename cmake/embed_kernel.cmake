@@ -0,0 +1,15 @@
+# Turns an OpenCL source file into a header holding it as a null-terminated char array.
+# Usage: cmake -DINPUT=<kernel.cl> -DOUTPUT=<header.h> -DNAME=<symbol> -P embed_kernel.cmake
+
+file(READ "${INPUT}" content HEX)
+# Keep the generated lines short, 16 bytes each
+string(REGEX REPLACE "(................................)" "\\1\n    " content "${content}")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," content "${content}")
+
+file(WRITE "${OUTPUT}.tmp"
+        "// Generated from ${INPUT}, do not edit\n"
+        "#pragma once\n\n"
+        "static const unsigned char ${NAME}[] = {\n    ${content}0x00\n};\n")
+# Only touch the header when the kernel changed, so dependants are not rebuilt needlessly
+file(COPY_FILE "${OUTPUT}.tmp" "${OUTPUT}" ONLY_IF_DIFFERENT)
+file(REMOVE "${OUTPUT}.tmp")
@@ -0,0 +1,66 @@
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include "NeuralNetwork.h"
+
+#ifndef NEURALDIGITRECON_ASYNCVALIDATOR_H
+#define NEURALDIGITRECON_ASYNCVALIDATOR_H
+
+
+// Measures the accuracy of a network on held-out data while it keeps training.
+// start() snapshots the weights and biases on the device, then a background thread runs a
+// forward-only pass over the snapshot on a second command queue with its own neuron buffer,
+// so the training queue and buffers are never touched by validation.
+class AsyncValidator {
+public:
+    // Called from the validation thread with the tag passed to start() and the accuracy in percent.
+    // It runs concurrently with training, so it must synchronise any state it shares with the caller.
+    using Callback = std::function<void(int tag, double accuracy)>;
+
+    // `images` and `targets` must outlive the validator
+    AsyncValidator(NeuralNetwork &network, const std::vector<std::vector<double>> &images,
+                   const std::vector<int> &targets, Callback callback);
+
+    ~AsyncValidator();
+
+    AsyncValidator(const AsyncValidator &) = delete;
+
+    AsyncValidator &operator=(const AsyncValidator &) = delete;
+
+    // Snapshot the current parameters and validate them in the background.
+    // Returns false without snapshotting if the previous validation is still running.
+    bool start(int tag);
+
+    // Block until the running validation, if any, has reported
+    void wait();
+
+    bool busy() const { return running; }
+
+private:
+    NeuralNetwork &network;
+    const std::vector<std::vector<double>> &images;
+    const std::vector<int> &targets;
+    Callback callback;
+
+    std::vector<int> topology;
+    std::shared_ptr<CLRuntime> runtime_;
+
+    cl_command_queue queue_{};
+    cl_kernel kernelFF{};
+    cl_mem weightsSnapshot{};
+    cl_mem biasesSnapshot{};
+    cl_mem neuronsBuffer{};
+    cl_mem topologyBuffer{};
+
+    std::thread worker;
+    std::atomic<bool> running{false};
+
+    void run(int tag, cl_event snapshotDone);
+
+    void release();
+};
+
+
+#endif //NEURALDIGITRECON_ASYNCVALIDATOR_H
@@ -0,0 +1,59 @@
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#ifdef __APPLE__
+#include <OpenCL/cl.h>
+#else
+
+#include <CL/cl.h>
+
+#endif
+
+#ifndef NEURALDIGITRECON_CLRUNTIME_H
+#define NEURALDIGITRECON_CLRUNTIME_H
+
+
+// Owns the OpenCL device, context and compiled kernel program.
+// One runtime can be shared by many networks, each of them only creates its own
+// command queue, buffers and kernel objects.
+class CLRuntime {
+public:
+    CLRuntime() = default;
+
+    ~CLRuntime();
+
+    CLRuntime(const CLRuntime &) = delete;
+
+    CLRuntime &operator=(const CLRuntime &) = delete;
+
+    // Discover the device, create the context and build the kernel program. Safe to call again once ready.
+    bool init();
+
+    bool ready() const { return program_ != nullptr; }
+
+    // New in-order command queue on the shared context, owned by the caller
+    cl_command_queue createQueue() const;
+
+    cl_device_id device() const { return device_; }
+
+    cl_context context() const { return context_; }
+
+    cl_program program() const { return program_; }
+
+    std::string read_kernel_file(const std::string &filename);
+
+private:
+    cl_platform_id platform_{};
+    cl_device_id device_{};
+    cl_context context_{};
+    cl_program program_{};
+
+    // Platform and device discovery, context creation
+    bool createContext();
+};
+
+
+#endif //NEURALDIGITRECON_CLRUNTIME_H
@@ -2,6 +2,7 @@
 #include <utility>
 #include <utility>
 #include "Neuron.h"
+#include "SparseMatrix.h"
 #include "vector"
 
 #ifndef NEURALDIGITRECON_LAYER_H
@@ -13,6 +14,7 @@ struct Layer {
     std::vector<double> weights;
     std::vector<double> biases;
     std::vector<double> biasWeights;
+    SparseMatrix sparseWeights;
     Layer(int numNeurons, int numNeuronsPrev, int layerId) {
 
         neurons.resize(numNeurons); // Resize the neurons vector
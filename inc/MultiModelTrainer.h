@@ -0,0 +1,45 @@
+#include <vector>
+#include <memory>
+#include "NeuralNetwork.h"
+#include "CLRuntime.h"
+
+#ifndef NEURALDIGITRECON_MULTIMODELTRAINER_H
+#define NEURALDIGITRECON_MULTIMODELTRAINER_H
+
+
+struct ModelConfig {
+    std::vector<int> topology;
+    double learningRate = 0.0005;
+    unsigned seed = 0;
+};
+
+// Trains several networks side by side on one shared runtime, e.g. for ensembles or
+// hyperparameter sweeps. Every network keeps its own command queue; per sample the work of
+// all networks is enqueued and flushed before the host waits, so the device can overlap the
+// small kernels of different models instead of idling between them.
+class MultiModelTrainer {
+public:
+    MultiModelTrainer(std::shared_ptr<CLRuntime> runtime, const std::vector<ModelConfig> &configs);
+
+    // One pass over the data for every model, returns the correct guesses of each model
+    std::vector<int> trainEpoch(const std::vector<std::vector<double>> &images, const std::vector<int> &targets);
+
+    // Forward-only pass, returns the correct guesses of each model
+    std::vector<int> evaluate(const std::vector<std::vector<double>> &images, const std::vector<int> &targets);
+
+    // Majority vote of all models over the data, returns the correct guesses of the ensemble
+    int evaluateEnsemble(const std::vector<std::vector<double>> &images, const std::vector<int> &targets);
+
+    NeuralNetwork &model(size_t i) { return *models[i]; }
+
+    size_t size() const { return models.size(); }
+
+private:
+    std::shared_ptr<CLRuntime> runtime_;
+    std::vector<std::unique_ptr<NeuralNetwork>> models;
+
+    void finishAll();
+};
+
+
+#endif //NEURALDIGITRECON_MULTIMODELTRAINER_H
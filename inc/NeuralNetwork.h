@@ -6,7 +6,10 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <memory>
 #include "Layer.h"
+#include "CLRuntime.h"
 
 #ifdef __APPLE__
 #include <OpenCL/cl.h>
@@ -24,7 +27,10 @@ class NeuralNetwork {
 public:
     int guess = -1;
 
-    NeuralNetwork(const std::vector<int> &topology);
+    // Networks passed the same runtime share its device, context and compiled program.
+    // Without a runtime the network creates a private one. A seed of 0 picks a clock based seed.
+    explicit NeuralNetwork(const std::vector<int> &topology, std::shared_ptr<CLRuntime> runtime = nullptr,
+                           double learningRate = 0.0005, unsigned seed = 0);
 
     ~NeuralNetwork();
 
@@ -37,9 +43,54 @@ public:
 
     void backPropagate(int target);
 
-    std::vector<double> readCustom();
+    // Asynchronous variants: enqueue the work without waiting for the device.
+    // Call finish() before reading `guess` or enqueueing the next sample.
+    bool enqueueFeedForward(const std::vector<double> &input);
+
+    bool enqueueBackPropagate(int target);
+
+    // Flush the queue so the device starts working while the host enqueues other networks
+    void flush();
+
+    // Wait for the queue and update `guess` from the last enqueued feed forward
+    void finish();
+
+    // Zero the smallest-magnitude weights until `sparsity` (0..1) of all weights are zero,
+    // then rebuild the CSR copies used by the sparse inference paths.
+    // One-shot pruning for a trained model: back propagation does not keep pruned weights at zero.
+    bool prune(double sparsity);
+
+    // Dense weights of all layers, in weightsBuffer order
+    std::vector<double> getWeights();
+
+    // Overwrite the dense weights, e.g. to undo prune(). The CSR copies keep the last pruned state.
+    bool setWeights(const std::vector<double> &weights);
+
+    // Inference over the pruned CSR weights on the OpenCL device
+    void feedForwardSparse(std::vector<double> &input);
+
+    // Inference over the pruned CSR weights on the host
+    void feedForwardSparseCPU(const std::vector<double> &input);
+
+    // Enqueue a device-side copy of the current weights and biases into the given buffers on the
+    // training queue. `event` signals when the copy is done and must be released by the caller.
+    bool snapshotParameters(cl_mem weightsDst, cl_mem biasesDst, cl_event *event);
+
+    std::shared_ptr<CLRuntime> runtime() const { return runtime_; }
+
+    std::vector<int> topology() const;
 
-    std::string read_kernel_file(const std::string &filename);
+    int weightCount() const { return totalWeights; }
+
+    int biasCount() const { return totalBiases; }
+
+    int neuronCount() const { return totalNeurons; }
+
+    size_t denseModelSize() const;
+
+    size_t sparseModelSize() const;
+
+    std::vector<double> readCustom();
 
 private:
     int totalWeights;
@@ -49,10 +100,12 @@ private:
 
     std::vector<Layer> layers;
     double avg_error = 0.0;
+    double learningRate;
+    unsigned seed;
 
-    const char *kernelSource{};
+    std::vector<Neuron> inputNeurons;  // staging for the non-blocking input upload
 
-    cl_program program{};
+    std::shared_ptr<CLRuntime> runtime_;
 
     cl_mem weightsBuffer{};
     cl_mem biasesBuffer{};
@@ -60,13 +113,25 @@ private:
     cl_mem deltasBuffer{};
     cl_mem topologyBuffer{};
 
+    cl_mem rowPtrBuffer{};
+    cl_mem colIdxBuffer{};
+    cl_mem valuesBuffer{};
+    std::vector<int> rowPtrOffsets;  // first rowPtr entry of every layer in rowPtrBuffer
+
     cl_kernel kernelFF{};
     cl_kernel kernelBP{};
+    cl_kernel kernelSparseFF{};
+
+    cl_context context_;           // OpenCL context, owned by runtime_
+    cl_command_queue commandQueue_; // Command queue of this network
+
+    void updateGuess();
+
+    void release();
+
+    bool readParameters();
 
-    cl_platform_id platform_;      // OpenCL platform
-    cl_device_id device_;          // OpenCL device
-    cl_context context_;           // OpenCL context
-    cl_command_queue commandQueue_; // Command queue for the device
+    bool buildSparse();
 
     template<typename T>
     cl_mem createReadBufferFromVector(std::vector<T> &input, cl_mem_flags flags) {
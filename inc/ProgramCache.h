@@ -0,0 +1,52 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+
+#ifdef __APPLE__
+#include <OpenCL/cl.h>
+#else
+
+#include <CL/cl.h>
+
+#endif
+
+#ifndef NEURALDIGITRECON_PROGRAMCACHE_H
+#define NEURALDIGITRECON_PROGRAMCACHE_H
+
+
+// On-disk cache of compiled program binaries (CL_PROGRAM_BINARIES).
+// Entries are keyed by device, driver version, build options and a hash of the kernel source,
+// so any change to one of them makes the runtime build from source again.
+class ProgramCache {
+public:
+    // $NEURAL_KERNEL_CACHE if set, else $XDG_CACHE_HOME/neural or ~/.cache/neural,
+    // the system temp directory only when no per-user location exists
+    explicit ProgramCache(std::filesystem::path directory = defaultDirectory());
+
+    static std::filesystem::path defaultDirectory();
+
+    std::string key(cl_device_id device, const std::string &options, const std::string &source) const;
+
+    // Built program from the cached binary, nullptr on a miss or when the binary is rejected
+    cl_program load(cl_context context, cl_device_id device, const std::string &key,
+                    const std::string &options) const;
+
+    bool store(cl_program program, const std::string &key) const;
+
+private:
+    std::filesystem::path directory;
+
+    std::filesystem::path entryPath(const std::string &key) const;
+
+    // Cache directory exists, is owned by the current user and writable only by them.
+    // With `create` a missing directory is created owner-only; an untrusted existing one is reported.
+    bool trustedDirectory(bool create) const;
+
+    static uint64_t hash(const std::string &data);
+};
+
+
+#endif //NEURALDIGITRECON_PROGRAMCACHE_H
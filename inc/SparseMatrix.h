@@ -0,0 +1,46 @@
+#include <vector>
+#include <cstddef>
+#include <cmath>
+
+#ifndef NEURALDIGITRECON_SPARSEMATRIX_H
+#define NEURALDIGITRECON_SPARSEMATRIX_H
+
+// Compressed sparse row (CSR) copy of one layer's weight matrix.
+// Rows are the neurons of the layer, columns the neurons of the previous layer,
+// matching the row-major layout of Layer::weights.
+struct SparseMatrix {
+    int rows = 0;
+    int cols = 0;
+    std::vector<int> rowPtr;     // rows + 1 entries, start of every row in colIdx/values
+    std::vector<int> colIdx;     // column of every stored weight
+    std::vector<double> values;  // stored (non-zero) weights
+
+    SparseMatrix() = default;
+
+    SparseMatrix(const std::vector<double> &dense, int numRows, int numCols) : rows(numRows), cols(numCols) {
+        rowPtr.reserve(numRows + 1);
+        rowPtr.push_back(0);
+        for (int r = 0; r < numRows; r++) {
+            for (int c = 0; c < numCols; c++) {
+                double w = dense[r * numCols + c];
+                if (w != 0.0) {
+                    colIdx.push_back(c);
+                    values.push_back(w);
+                }
+            }
+            rowPtr.push_back(static_cast<int>(values.size()));
+        }
+    }
+
+    size_t nonZeros() const {
+        return values.size();
+    }
+
+    // Bytes needed to store the matrix in CSR form
+    size_t sizeInBytes() const {
+        return rowPtr.size() * sizeof(int) + colIdx.size() * sizeof(int) + values.size() * sizeof(double);
+    }
+};
+
+
+#endif //NEURALDIGITRECON_SPARSEMATRIX_H
@@ -1,10 +1,14 @@
 #include <stdio.h>
 #include <iostream>
 #include <vector>
+#include <chrono>
+#include <mutex>
 
 #include "inc/NeuralNetwork.h"
 
 #include "inc/input_parse.h"
+#include "inc/AsyncValidator.h"
+#include "inc/MultiModelTrainer.h"
 
 // OpenCL includes
 #ifdef __APPLE__
@@ -25,15 +29,31 @@ int main() {
 
     std::vector<int> topology{784, 256, 10};
 
-    NeuralNetwork NN{topology};
+    // One device context and compiled program for every network of this run
+    auto runtime = std::make_shared<CLRuntime>();
+    NeuralNetwork NN{topology, runtime};
 
 
     std::vector<int> guessed{0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-    std::vector<int> TEST_guessed{0, 0};
 
+    // Validation runs on a weight snapshot in the background while the next epoch trains.
+    // Results are collected here and printed between epochs, so they don't cut into the progress bar.
+    std::mutex validationMutex;
+    std::vector<std::pair<int, double>> validationResults;
+    AsyncValidator validator{NN, TEST_images, TEST_target, [&](int epoch, double accuracy) {
+        std::lock_guard<std::mutex> lock(validationMutex);
+        validationResults.emplace_back(epoch, accuracy);
+    }};
+    auto printValidation = [&]() {
+        std::lock_guard<std::mutex> lock(validationMutex);
+        for (const auto &[epoch, accuracy] : validationResults) {
+            std::cout<<"percentage of guesses for TEST data after epoch "<<epoch<<": "<<accuracy<<std::endl;
+        }
+        validationResults.clear();
+    };
 
 
-    for (int j = 0; j < 4; j++) {
+    for (int j = 0; j < 9; j++) {
         for (int i = 0; i < images.size(); i++) {
             NN.feedForward(images[i]);
             if(NN.guess == target[i]){
@@ -45,41 +65,74 @@ int main() {
         double result = (double)guessed[j]/(double)images.size()*100;
         std::cout<<"Done Epoch "<<j<<std::endl;
         std::cout<<"percentage of guesses for epoch "<<j<<": "<<result<<std::endl;
-    }
-
-    for (int i = 0; i < TEST_images.size(); i++) {
-        NN.feedForward(TEST_images[i]);
-        if(NN.guess == TEST_target[i]){
-            TEST_guessed[0]++;
+        printValidation();
+        // Validations must not overlap, wait for the previous epoch rather than skipping this one
+        if (validator.busy()) {
+            std::cout<<"waiting for TEST validation of the previous epoch"<<std::endl;
+            validator.wait();
+            printValidation();
+        }
+        if (!validator.start(j)) {
+            std::cerr<<"TEST validation for epoch "<<j<<" could not be started."<<std::endl;
         }
-        NN.backPropagate(TEST_target[i]);
     }
-    double test_res0 = static_cast<double>(TEST_guessed[0])/(double)TEST_images.size()*100;
-    std::cout<<"percentage of guesses for TEST data1: "<<test_res0<<std::endl;
 
-    for (int j = 4; j < 9; j++) {
-        for (int i = 0; i < images.size(); i++) {
-            NN.feedForward(images[i]);
-            if(NN.guess == target[i]){
-                guessed[j]++;
-            }
-            NN.backPropagate(target[i]);
-            if(i % 10000 == 0) std::cout<<"| ";
+
+    validator.wait();
+    printValidation();
+
+    // Prune the trained model to increasing sparsity levels and compare the sparse inference paths.
+    // Levels must increase: pruning only ever removes more of the smallest weights.
+    // The dense weights are restored afterwards so the interactive loop serves the full model.
+    std::vector<double> denseWeights = NN.getWeights();
+    std::vector<double> sparsityLevels{0.0, 0.5, 0.7, 0.8, 0.9, 0.95};
+    std::cout<<"sparsity | accuracy GPU | accuracy CPU | size (KB) | GPU img/s | CPU img/s"<<std::endl;
+    for (double sparsity : sparsityLevels) {
+        NN.prune(sparsity);
+
+        int correctGPU = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < TEST_images.size(); i++) {
+            NN.feedForwardSparse(TEST_images[i]);
+            if(NN.guess == TEST_target[i]) correctGPU++;
         }
-        double result = (double)guessed[j]/(double)images.size()*100;
-        std::cout<<"Done Epoch "<<j<<std::endl;
-        std::cout<<"percentage of guesses for epoch "<<j<<": "<<result<<std::endl;
-    }
+        double secondsGPU = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-    for (int i = 0; i < TEST_images.size(); i++) {
-        NN.feedForward(TEST_images[i]);
-        if(NN.guess == TEST_target[i]){
-            TEST_guessed[1]++;
+        int correctCPU = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < TEST_images.size(); i++) {
+            NN.feedForwardSparseCPU(TEST_images[i]);
+            if(NN.guess == TEST_target[i]) correctCPU++;
         }
-        NN.backPropagate(TEST_target[i]);
+        double secondsCPU = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout<<sparsity*100<<"% | "
+                 <<(double)correctGPU/(double)TEST_images.size()*100<<"% | "
+                 <<(double)correctCPU/(double)TEST_images.size()*100<<"% | "
+                 <<NN.sparseModelSize()/1024<<" (dense "<<NN.denseModelSize()/1024<<") | "
+                 <<TEST_images.size()/secondsGPU<<" | "
+                 <<TEST_images.size()/secondsCPU<<std::endl;
+    }
+    NN.setWeights(denseWeights);
+
+    // Learning-rate sweep trained side by side on the shared runtime, then evaluated alone and as an ensemble
+    std::vector<ModelConfig> sweep{
+            {topology, 0.0005, 1},
+            {topology, 0.001, 2},
+            {topology, 0.002, 3},
+            {{784, 128, 10}, 0.001, 4},
+    };
+    MultiModelTrainer trainer{runtime, sweep};
+    std::vector<int> sweepTrained = trainer.trainEpoch(images, target);
+    std::vector<int> sweepTested = trainer.evaluate(TEST_images, TEST_target);
+    for (size_t m = 0; m < trainer.size(); m++) {
+        std::cout<<"sweep model "<<m<<" (learning rate "<<sweep[m].learningRate<<"): train "
+                 <<(double)sweepTrained[m]/(double)images.size()*100<<"%, TEST "
+                 <<(double)sweepTested[m]/(double)TEST_images.size()*100<<"%"<<std::endl;
     }
-    double test_res = static_cast<double>(TEST_guessed[1])/(double)TEST_images.size()*100;
-    std::cout<<"percentage of guesses for TEST data2: "<<test_res<<std::endl;
+    int ensembleCorrect = trainer.evaluateEnsemble(TEST_images, TEST_target);
+    std::cout<<"percentage of guesses for TEST data by the sweep ensemble: "
+             <<(double)ensembleCorrect/(double)TEST_images.size()*100<<std::endl;
 
 
     std::vector<double> input;
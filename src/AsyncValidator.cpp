@@ -0,0 +1,153 @@
+#include "../inc/AsyncValidator.h"
+
+// Samples enqueued per host synchronisation
+static const size_t chunkSize = 256;
+
+AsyncValidator::AsyncValidator(NeuralNetwork &network, const std::vector<std::vector<double>> &images,
+                               const std::vector<int> &targets, Callback callback)
+        : network(network), images(images), targets(targets), callback(std::move(callback)),
+          topology(network.topology()), runtime_(network.runtime()) {
+    if (!runtime_ || !runtime_->ready()) {
+        throw std::runtime_error{"OpenCL runtime not initialized"};
+    }
+    cl_context context = runtime_->context();
+    cl_int err;
+
+    queue_ = runtime_->createQueue();
+    if (!queue_) {
+        throw std::runtime_error{"Error creating validation command queue"};
+    }
+
+    // A kernel object of our own, setting arguments on the training kernel from this thread would race
+    kernelFF = clCreateKernel(runtime_->program(), "feed_forward", &err);
+    if (err != CL_SUCCESS || !kernelFF) {
+        // The destructor does not run when the constructor throws
+        kernelFF = nullptr;
+        release();
+        throw std::runtime_error{"Error creating validation kernel"};
+    }
+
+    cl_int errW, errB, errN, errT;
+    weightsSnapshot = clCreateBuffer(context, CL_MEM_READ_WRITE, network.weightCount() * sizeof(double), nullptr,
+                                     &errW);
+    biasesSnapshot = clCreateBuffer(context, CL_MEM_READ_WRITE, network.biasCount() * sizeof(double), nullptr,
+                                    &errB);
+    neuronsBuffer = clCreateBuffer(context, CL_MEM_READ_WRITE, network.neuronCount() * sizeof(Neuron), nullptr,
+                                   &errN);
+    topologyBuffer = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                    topology.size() * sizeof(int), topology.data(), &errT);
+    if (errW != CL_SUCCESS || errB != CL_SUCCESS || errN != CL_SUCCESS || errT != CL_SUCCESS) {
+        // The destructor does not run when the constructor throws
+        release();
+        throw std::runtime_error{"Error creating validation buffers"};
+    }
+}
+
+bool AsyncValidator::start(int tag) {
+    if (running || !queue_ || !kernelFF) return false;
+    if (worker.joinable()) worker.join();
+
+    cl_event snapshotDone;
+    if (!network.snapshotParameters(weightsSnapshot, biasesSnapshot, &snapshotDone)) return false;
+
+    running = true;
+    worker = std::thread(&AsyncValidator::run, this, tag, snapshotDone);
+    return true;
+}
+
+void AsyncValidator::run(int tag, cl_event snapshotDone) {
+    cl_int err = clWaitForEvents(1, &snapshotDone);
+    clReleaseEvent(snapshotDone);
+    if (err != CL_SUCCESS) {
+        std::cerr << "Failed to wait for weight snapshot." << std::endl;
+        running = false;
+        return;
+    }
+
+    err = clSetKernelArg(kernelFF, 0, sizeof(cl_mem), &neuronsBuffer);
+    err |= clSetKernelArg(kernelFF, 1, sizeof(cl_mem), &biasesSnapshot);
+    err |= clSetKernelArg(kernelFF, 2, sizeof(cl_mem), &weightsSnapshot);
+    err |= clSetKernelArg(kernelFF, 3, sizeof(cl_mem), &topologyBuffer);
+    if (err != CL_SUCCESS) {
+        std::cerr << "Error setting validation kernel arguments." << std::endl;
+        running = false;
+        return;
+    }
+
+    size_t inputs = topology.front();
+    size_t outputs = topology.back();
+    size_t outputOffset = network.neuronCount() - outputs;
+
+    std::vector<Neuron> staging;
+    std::vector<Neuron> results;
+    int correct = 0;
+
+    for (size_t first = 0; first < images.size(); first += chunkSize) {
+        size_t count = std::min(chunkSize, images.size() - first);
+        staging.assign(count * inputs, Neuron{0.0});
+        results.resize(count * outputs);
+
+        // The in-order queue reuses one neuron buffer for every sample of the chunk
+        for (size_t s = 0; s < count; s++) {
+            const std::vector<double> &image = images[first + s];
+            for (size_t j = 0; j < image.size() && j < inputs; j++) {
+                staging[s * inputs + j].value = image[j];
+            }
+
+            err = clEnqueueWriteBuffer(queue_, neuronsBuffer, CL_FALSE, 0, inputs * sizeof(Neuron),
+                                       &staging[s * inputs], 0, nullptr, nullptr);
+            for (int layer = 1; layer < topology.size(); layer++) {
+                err |= clSetKernelArg(kernelFF, 4, sizeof(int), &layer);
+                size_t globalWorkSize = topology[layer];
+                err |= clEnqueueNDRangeKernel(queue_, kernelFF, 1, nullptr, &globalWorkSize, nullptr, 0, nullptr,
+                                              nullptr);
+            }
+            err |= clEnqueueReadBuffer(queue_, neuronsBuffer, CL_FALSE, outputOffset * sizeof(Neuron),
+                                       outputs * sizeof(Neuron), &results[s * outputs], 0, nullptr, nullptr);
+            if (err != CL_SUCCESS) {
+                std::cerr << "Failed to enqueue validation pass." << std::endl;
+                clFinish(queue_);
+                running = false;
+                return;
+            }
+        }
+        clFinish(queue_);
+
+        for (size_t s = 0; s < count; s++) {
+            int guess = -1;
+            double guessVal = 0.0;
+            for (size_t o = 0; o < outputs; o++) {
+                if (results[s * outputs + o].value > guessVal) {
+                    guess = o;
+                    guessVal = results[s * outputs + o].value;
+                }
+            }
+            if (guess == targets[first + s]) correct++;
+        }
+    }
+
+    double accuracy = images.empty() ? 0.0 : (double) correct / (double) images.size() * 100;
+    if (callback) callback(tag, accuracy);
+    running = false;
+}
+
+void AsyncValidator::wait() {
+    if (worker.joinable()) worker.join();
+}
+
+AsyncValidator::~AsyncValidator() {
+    wait();
+    release();
+}
+
+void AsyncValidator::release() {
+    if (weightsSnapshot) clReleaseMemObject(weightsSnapshot);
+    if (biasesSnapshot) clReleaseMemObject(biasesSnapshot);
+    if (neuronsBuffer) clReleaseMemObject(neuronsBuffer);
+    if (topologyBuffer) clReleaseMemObject(topologyBuffer);
+    if (kernelFF) clReleaseKernel(kernelFF);
+    if (queue_) clReleaseCommandQueue(queue_);
+    weightsSnapshot = biasesSnapshot = neuronsBuffer = topologyBuffer = nullptr;
+    kernelFF = nullptr;
+    queue_ = nullptr;
+}
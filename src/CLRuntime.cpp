@@ -0,0 +1,141 @@
+#include "../inc/CLRuntime.h"
+#include "../inc/ProgramCache.h"
+#include "kernelSource.h"
+
+#include <cstdlib>
+
+// Options passed to clBuildProgram, part of the binary cache key
+static const std::string buildOptions = "";
+
+std::string CLRuntime::read_kernel_file(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open kernel file: " << filename << std::endl;
+        return "";
+    }
+
+    std::stringstream buf;
+    buf << file.rdbuf();
+    return buf.str();
+}
+
+bool CLRuntime::createContext() {
+    cl_int err;
+
+    // Step 1: Get the number of platforms available
+    cl_uint platformCount = 0;
+    err = clGetPlatformIDs(0, nullptr, &platformCount);
+    if (err != CL_SUCCESS || platformCount == 0) {
+        std::cerr << "Failed to get OpenCL platform count or no platforms available." << std::endl;
+        return false;
+    }
+
+    // Step 2: Get platform IDs
+    std::vector<cl_platform_id> platforms(platformCount);
+    err = clGetPlatformIDs(platformCount, platforms.data(), nullptr);
+    if (err != CL_SUCCESS) {
+        std::cerr << "Failed to get OpenCL platform IDs." << std::endl;
+        return false;
+    }
+
+    // Step 3: Select a platform (for simplicity, choose the first one)
+    platform_ = platforms[0];
+
+    // Step 4: Get the number of devices for the selected platform
+    cl_uint deviceCount = 0;
+    err = clGetDeviceIDs(platform_, CL_DEVICE_TYPE_GPU, 0, nullptr, &deviceCount);
+    if (err != CL_SUCCESS || deviceCount == 0) {
+        std::cerr << "Failed to get OpenCL device count or no devices available." << std::endl;
+        return false;
+    }
+
+    // Step 5: Get device IDs (we choose the first one for simplicity)
+    std::vector<cl_device_id> devices(deviceCount);
+    err = clGetDeviceIDs(platform_, CL_DEVICE_TYPE_GPU, deviceCount, devices.data(), nullptr);
+    if (err != CL_SUCCESS) {
+        std::cerr << "Failed to get OpenCL device IDs." << std::endl;
+        return false;
+    }
+
+    device_ = devices[0];
+
+    // Step 6: Create an OpenCL context
+    context_ = clCreateContext(nullptr, 1, &device_, nullptr, nullptr, &err);
+    if (err != CL_SUCCESS || !context_) {
+        std::cerr << "Failed to create OpenCL context." << std::endl;
+        context_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool CLRuntime::init() {
+    if (ready()) return true;
+
+    // A failed program build keeps the context, a retry only builds the program again
+    if (!context_ && !createContext()) return false;
+
+    cl_int err;
+
+    // Step 7: Compile the kernels once for every network using this runtime.
+    // The source is embedded at build time, NEURAL_KERNEL_FILE can point at a .cl file while developing kernels.
+    std::string kernelCode = reinterpret_cast<const char *>(kernelFnSource);
+    if (const char *kernelFile = std::getenv("NEURAL_KERNEL_FILE")) {
+        kernelCode = read_kernel_file(kernelFile);
+        if (kernelCode.empty()) return false;
+    }
+
+    ProgramCache cache;
+    const std::string cacheKey = cache.key(device_, buildOptions, kernelCode);
+
+    // Warm start: reuse the binary of an earlier run on the same device, driver and source
+    cl_program program = cache.load(context_, device_, cacheKey, buildOptions);
+    if (program) {
+        program_ = program;
+        return true;
+    }
+
+    const char *kernelSource = kernelCode.c_str();
+    program = clCreateProgramWithSource(context_, 1, &kernelSource, nullptr, &err);
+    if (err != CL_SUCCESS || !program) {
+        std::cerr << "Failed to create OpenCL program." << std::endl;
+        return false;
+    }
+
+    err = clBuildProgram(program, 1, &device_, buildOptions.c_str(), nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        std::cerr << "Failed to build OpenCL program." << std::endl;
+        size_t logSize;
+        clGetProgramBuildInfo(program, device_, CL_PROGRAM_BUILD_LOG, 0, nullptr, &logSize);
+
+        char *log = new char[logSize];
+        clGetProgramBuildInfo(program, device_, CL_PROGRAM_BUILD_LOG, logSize, log, nullptr);
+
+        std::cerr << "Build log:\n" << log << std::endl;
+        delete[] log;
+        clReleaseProgram(program);
+        return false;
+    }
+
+    if (!cache.store(program, cacheKey)) {
+        std::cerr << "Could not write kernel binary cache, the next start compiles again." << std::endl;
+    }
+
+    program_ = program;
+    return true;
+}
+
+cl_command_queue CLRuntime::createQueue() const {
+    cl_int err;
+    cl_command_queue queue = clCreateCommandQueue(context_, device_, 0, &err);
+    if (err != CL_SUCCESS || !queue) {
+        std::cerr << "Failed to create OpenCL command queue." << std::endl;
+        return nullptr;
+    }
+    return queue;
+}
+
+CLRuntime::~CLRuntime() {
+    if (program_) clReleaseProgram(program_);
+    if (context_) clReleaseContext(context_);
+}
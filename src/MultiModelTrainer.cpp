@@ -0,0 +1,77 @@
+#include "../inc/MultiModelTrainer.h"
+
+MultiModelTrainer::MultiModelTrainer(std::shared_ptr<CLRuntime> runtime, const std::vector<ModelConfig> &configs)
+        : runtime_(std::move(runtime)) {
+    if (!runtime_) runtime_ = std::make_shared<CLRuntime>();
+    if (!runtime_->init()) {
+        throw std::runtime_error{"Error initializing OpenCL runtime"};
+    }
+
+    for (const ModelConfig &config: configs) {
+        models.push_back(std::make_unique<NeuralNetwork>(config.topology, runtime_, config.learningRate, config.seed));
+    }
+}
+
+void MultiModelTrainer::finishAll() {
+    // Submit every queue first so the models run concurrently, then wait for all of them
+    for (auto &model: models) model->flush();
+    for (auto &model: models) model->finish();
+}
+
+std::vector<int> MultiModelTrainer::trainEpoch(const std::vector<std::vector<double>> &images,
+                                               const std::vector<int> &targets) {
+    std::vector<int> correct(models.size(), 0);
+
+    for (size_t i = 0; i < images.size(); i++) {
+        for (auto &model: models) {
+            model->enqueueFeedForward(images[i]);
+            model->enqueueBackPropagate(targets[i]);
+        }
+        finishAll();
+
+        for (size_t m = 0; m < models.size(); m++) {
+            if (models[m]->guess == targets[i]) correct[m]++;
+        }
+    }
+    return correct;
+}
+
+std::vector<int> MultiModelTrainer::evaluate(const std::vector<std::vector<double>> &images,
+                                             const std::vector<int> &targets) {
+    std::vector<int> correct(models.size(), 0);
+
+    for (size_t i = 0; i < images.size(); i++) {
+        for (auto &model: models) {
+            model->enqueueFeedForward(images[i]);
+        }
+        finishAll();
+
+        for (size_t m = 0; m < models.size(); m++) {
+            if (models[m]->guess == targets[i]) correct[m]++;
+        }
+    }
+    return correct;
+}
+
+int MultiModelTrainer::evaluateEnsemble(const std::vector<std::vector<double>> &images,
+                                        const std::vector<int> &targets) {
+    int correct = 0;
+
+    for (size_t i = 0; i < images.size(); i++) {
+        for (auto &model: models) {
+            model->enqueueFeedForward(images[i]);
+        }
+        finishAll();
+
+        std::vector<int> votes;
+        for (auto &model: models) {
+            if (model->guess < 0) continue;
+            if (model->guess >= votes.size()) votes.resize(model->guess + 1, 0);
+            votes[model->guess]++;
+        }
+        if (votes.empty()) continue;
+        int winner = std::max_element(votes.begin(), votes.end()) - votes.begin();
+        if (winner == targets[i]) correct++;
+    }
+    return correct;
+}
@@ -1,17 +1,5 @@
 #include "../inc/NeuralNetwork.h"
 
-std::string NeuralNetwork::read_kernel_file(const std::string &filename) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open kernel file: " << filename << std::endl;
-        return "";
-    }
-
-    std::stringstream buf;
-    buf << file.rdbuf();
-    return buf.str();
-}
-
 void NeuralNetwork::initialize_weights_and_biases() {
     // Step 1: Ensure OpenCL is initialized
     if (!context_ || !commandQueue_) {
@@ -28,7 +16,7 @@ void NeuralNetwork::initialize_weights_and_biases() {
 
     std::vector<double> seeds{};
     seeds.resize(totalWeights + totalBiases, 0.0);
-    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+    if (seed == 0) seed = std::chrono::system_clock::now().time_since_epoch().count();
 
     std::default_random_engine generator(seed);
     std::uniform_int_distribution<long> distribution(1, RAND_MAX);
@@ -44,9 +32,10 @@ void NeuralNetwork::initialize_weights_and_biases() {
 
 
     // Step 5: Create the kernel for weight and bias initialization
-    cl_kernel kernel = clCreateKernel(program, "init", &err);
+    cl_kernel kernel = clCreateKernel(runtime_->program(), "init", &err);
     if (err != CL_SUCCESS || !kernel) {
         std::cerr << "Failed to create OpenCL kernel." << std::endl;
+        clReleaseMemObject(seedsBuffer);
         return;
     }
 
@@ -82,12 +71,15 @@ void NeuralNetwork::initialize_weights_and_biases() {
         }
 
     clReleaseKernel(kernel);
+    clReleaseMemObject(seedsBuffer);
 }
 
 
-NeuralNetwork::NeuralNetwork(const std::vector<int> &topology) : totalWeights(0), totalBiases(0), totalNeurons(0),
-                                                                 totalDeltas(0), platform_(nullptr), device_(nullptr),
-                                                                 context_(nullptr), commandQueue_(nullptr) {
+NeuralNetwork::NeuralNetwork(const std::vector<int> &topology, std::shared_ptr<CLRuntime> runtime,
+                             double learningRate, unsigned seed) : totalWeights(0), totalBiases(0), totalNeurons(0),
+                                                                   totalDeltas(0), learningRate(learningRate),
+                                                                   seed(seed), runtime_(std::move(runtime)),
+                                                                   context_(nullptr), commandQueue_(nullptr) {
 
     for (size_t i = 0; i < topology.size(); ++i) {
         layers.emplace_back(topology[i], (i == 0 ? 0 : topology[i - 1]), i);
@@ -99,24 +91,50 @@ NeuralNetwork::NeuralNetwork(const std::vector<int> &topology) : totalWeights(0)
         totalNeurons += layers[i].neurons.size();
         totalDeltas += layers[i].deltas.size();
     }
-    openCL_init(topology);
+    // Fail before any per-network OpenCL object exists, so nothing leaks
+    if (!runtime_) runtime_ = std::make_shared<CLRuntime>();
+    if (!runtime_->init()) {
+        throw std::runtime_error{"Error initializing OpenCL runtime"};
+    }
+    // The destructor does not run when the constructor throws, release what openCL_init created
+    bool initialized;
+    try {
+        initialized = openCL_init(topology);
+    } catch (...) {
+        release();
+        throw;
+    }
+    if (!initialized) {
+        release();
+        throw std::runtime_error{"Error creating OpenCL network objects"};
+    }
     // initialize weights and biases after constructing the layers
     initialize_weights_and_biases();
 
 }
 
 void NeuralNetwork::feedForward(std::vector<double> &input) {
+    if (!enqueueFeedForward(input)) return;
+    finish();
+}
+
+void NeuralNetwork::backPropagate(int target) {
+    if (!enqueueBackPropagate(target)) return;
+    clFinish(commandQueue_);
+}
+
+bool NeuralNetwork::enqueueFeedForward(const std::vector<double> &input) {
     if (!context_ || !commandQueue_) {
         std::cerr << "OpenCL context or command queue not initialized!" << std::endl;
-        return;
+        return false;
     }
-    std::vector<Neuron> inputNeurons(layers[0].neurons.size());
-    for (size_t j = 0; j < input.size(); j++) {
+    inputNeurons.resize(layers[0].neurons.size());
+    for (size_t j = 0; j < input.size() && j < inputNeurons.size(); j++) {
         inputNeurons[j].value = input[j];
     }
 
     cl_int err;
-    err = clEnqueueWriteBuffer(commandQueue_, neuronsBuffer, CL_TRUE, 0, inputNeurons.size() * sizeof(Neuron),
+    err = clEnqueueWriteBuffer(commandQueue_, neuronsBuffer, CL_FALSE, 0, inputNeurons.size() * sizeof(Neuron),
                                inputNeurons.data(), 0,
                                nullptr, nullptr);
     if (err != CL_SUCCESS) {
@@ -133,6 +151,7 @@ void NeuralNetwork::feedForward(std::vector<double> &input) {
     }
     int offset_n = layers[0].neurons.size();
 
+    // The queue is in-order, so every layer sees the previous one without a host round trip
     for (int i = 1; i < layers.size(); i++) {
         err = clSetKernelArg(kernelFF, 4, sizeof(int), &i);
 
@@ -146,42 +165,28 @@ void NeuralNetwork::feedForward(std::vector<double> &input) {
                                      nullptr);
         if (err != CL_SUCCESS) {
             std::cerr << "Failed to enqueue OpenCL kernel." << std::endl;
-            return;
+            return false;
         }
 
         if (i < layers.size()-1) offset_n += layers[i].neurons.size();
-
-
-        clFinish(commandQueue_);
-
     }
-    err = clEnqueueReadBuffer(commandQueue_, neuronsBuffer, CL_TRUE,
+    err = clEnqueueReadBuffer(commandQueue_, neuronsBuffer, CL_FALSE,
                               offset_n * sizeof(double),
                               layers.back().neurons.size() * sizeof(double),
                               layers.back().neurons.data(), 0, nullptr, nullptr);
 
     if (err != CL_SUCCESS) {
         std::cerr << "Failed to read neuron buffer. ERR code:" << std::endl;
-        return;
-    }
-
-    double guessVal = 0.0;
-    for (int i = 0; i < layers.back().neurons.size(); i++) {
-        double value = layers.back().neurons[i].value;
-        if (value > guessVal) {
-            guess = i;
-            guessVal = static_cast<double>(value);
-        }
+        return false;
     }
-
+    return true;
 }
 
-void NeuralNetwork::backPropagate(int target) {
+bool NeuralNetwork::enqueueBackPropagate(int target) {
     if (!context_ || !commandQueue_) {
         std::cerr << "OpenCL context or command queue not initialized!" << std::endl;
-        return;
+        return false;
     }
-    double learningRate = 0.0005;
     int totalLayers = layers.size();
 
     cl_int err;
@@ -200,7 +205,7 @@ void NeuralNetwork::backPropagate(int target) {
     }
 
     // Iterate over layers in reverse order
-    for (size_t layer = layers.size() - 1; layer > 0; layer--) {
+    for (int layer = layers.size() - 1; layer > 0; layer--) {
 
         // Set kernel arguments
         int isOutputLayer = (layer == layers.size() - 1);
@@ -221,102 +226,352 @@ void NeuralNetwork::backPropagate(int target) {
                                      nullptr);
         if (err != CL_SUCCESS) {
             std::cerr << "Failed to enqueue OpenCL kernel." << std::endl;
-            return;
+            return false;
         }
-//        int offset_n = 0;
-//        layer == 2 ? offset_n = 784*256 : 0;
-//        err = clEnqueueReadBuffer(commandQueue_, weightsBuffer, CL_TRUE,
-//                                  ( offset_n) * sizeof(double ),
-//                                  layers[layer].weights.size() * sizeof(double ),
-//                                  layers[layer].weights.data(), 0, nullptr, nullptr);
-//        if (err != CL_SUCCESS) {
-//            std::cerr << "Failed to read weights." << std::endl;
-//            return;
-//        }
-/// READ DATA BACK TO PROGRAM TO DEBUG
+    }
+    return true;
+}
 
-        clFinish(commandQueue_);
+void NeuralNetwork::flush() {
+    if (commandQueue_) clFlush(commandQueue_);
+}
 
+void NeuralNetwork::finish() {
+    if (!commandQueue_) return;
+    clFinish(commandQueue_);
+    updateGuess();
+}
+
+void NeuralNetwork::updateGuess() {
+    double guessVal = 0.0;
+    for (int i = 0; i < layers.back().neurons.size(); i++) {
+        double value = layers.back().neurons[i].value;
+        if (value > guessVal) {
+            guess = i;
+            guessVal = static_cast<double>(value);
+        }
     }
+}
 
+bool NeuralNetwork::readParameters() {
+    cl_int err;
+    size_t weightOffset = 0;
+    size_t biasOffset = 0;
 
+    for (size_t i = 1; i < layers.size(); i++) {
+        err = clEnqueueReadBuffer(commandQueue_, weightsBuffer, CL_TRUE,
+                                  weightOffset * sizeof(double),
+                                  layers[i].weights.size() * sizeof(double),
+                                  layers[i].weights.data(), 0, nullptr, nullptr);
+        err |= clEnqueueReadBuffer(commandQueue_, biasesBuffer, CL_TRUE,
+                                   biasOffset * sizeof(double),
+                                   layers[i].biasWeights.size() * sizeof(double),
+                                   layers[i].biasWeights.data(), 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) {
+            std::cerr << "Failed to read weights and biases." << std::endl;
+            return false;
+        }
+        weightOffset += layers[i].weights.size();
+        biasOffset += layers[i].biasWeights.size();
+    }
+    return true;
 }
 
+std::vector<double> NeuralNetwork::getWeights() {
+    std::vector<double> weights;
+    if (!context_ || !commandQueue_) {
+        std::cerr << "OpenCL context or command queue not initialized!" << std::endl;
+        return weights;
+    }
+    if (!readParameters()) return weights;
 
-bool NeuralNetwork::openCL_init(const std::vector<int> &topology) {
-    cl_int err;
+    weights.reserve(totalWeights);
+    for (size_t i = 1; i < layers.size(); i++) {
+        weights.insert(weights.end(), layers[i].weights.begin(), layers[i].weights.end());
+    }
+    return weights;
+}
 
-    // Step 1: Get the number of platforms available
-    cl_uint platformCount = 0;
-    err = clGetPlatformIDs(0, nullptr, &platformCount);
-    if (err != CL_SUCCESS || platformCount == 0) {
-        std::cerr << "Failed to get OpenCL platform count or no platforms available." << std::endl;
+bool NeuralNetwork::setWeights(const std::vector<double> &weights) {
+    if (!context_ || !commandQueue_) {
+        std::cerr << "OpenCL context or command queue not initialized!" << std::endl;
         return false;
     }
-
-    // Step 2: Get platform IDs
-    std::vector<cl_platform_id> platforms(platformCount);
-    err = clGetPlatformIDs(platformCount, platforms.data(), nullptr);
-    if (err != CL_SUCCESS) {
-        std::cerr << "Failed to get OpenCL platform IDs." << std::endl;
+    if (weights.size() != totalWeights) {
+        std::cerr << "Weight count does not match the network topology." << std::endl;
         return false;
     }
 
-    // Step 3: Select a platform (for simplicity, choose the first one)
-    platform_ = platforms[0];
+    size_t weightOffset = 0;
+    for (size_t i = 1; i < layers.size(); i++) {
+        std::copy(weights.begin() + weightOffset, weights.begin() + weightOffset + layers[i].weights.size(),
+                  layers[i].weights.begin());
+        weightOffset += layers[i].weights.size();
+    }
 
-    // Step 4: Get the number of devices for the selected platform
-    cl_uint deviceCount = 0;
-    err = clGetDeviceIDs(platform_, CL_DEVICE_TYPE_GPU, 0, nullptr, &deviceCount);
-    if (err != CL_SUCCESS || deviceCount == 0) {
-        std::cerr << "Failed to get OpenCL device count or no devices available." << std::endl;
+    cl_int err = clEnqueueWriteBuffer(commandQueue_, weightsBuffer, CL_TRUE, 0, totalWeights * sizeof(double),
+                                      weights.data(), 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        std::cerr << "Failed to write weights." << std::endl;
         return false;
     }
+    return true;
+}
 
-    // Step 5: Get device IDs (we choose the first one for simplicity)
-    std::vector<cl_device_id> devices(deviceCount);
-    err = clGetDeviceIDs(platform_, CL_DEVICE_TYPE_GPU, deviceCount, devices.data(), nullptr);
-    if (err != CL_SUCCESS) {
-        std::cerr << "Failed to get OpenCL device IDs." << std::endl;
+bool NeuralNetwork::prune(double sparsity) {
+    if (!context_ || !commandQueue_) {
+        std::cerr << "OpenCL context or command queue not initialized!" << std::endl;
         return false;
     }
+    if (!readParameters()) return false;
+
+    // Global magnitude threshold over all layers
+    std::vector<double> magnitudes;
+    magnitudes.reserve(totalWeights);
+    for (size_t i = 1; i < layers.size(); i++) {
+        for (double w: layers[i].weights) {
+            magnitudes.push_back(std::abs(w));
+        }
+    }
 
-    device_ = devices[0];
+    size_t toPrune = static_cast<size_t>(std::clamp(sparsity, 0.0, 1.0) * magnitudes.size());
+    if (toPrune > 0) {
+        std::nth_element(magnitudes.begin(), magnitudes.begin() + (toPrune - 1), magnitudes.end());
+        double threshold = magnitudes[toPrune - 1];
+
+        // Weights strictly below the threshold always go, ties are removed until the target is met
+        size_t below = 0;
+        for (size_t i = 1; i < layers.size(); i++) {
+            for (double w: layers[i].weights) {
+                if (std::abs(w) < threshold) below++;
+            }
+        }
+        size_t ties = toPrune - below;
+        for (size_t i = 1; i < layers.size(); i++) {
+            for (double &w: layers[i].weights) {
+                double m = std::abs(w);
+                if (m < threshold) {
+                    w = 0.0;
+                } else if (m == threshold && ties > 0) {
+                    w = 0.0;
+                    ties--;
+                }
+            }
+        }
+    }
 
-    // Step 6: Create an OpenCL context
-    context_ = clCreateContext(nullptr, 1, &device_, nullptr, nullptr, &err);
-    if (err != CL_SUCCESS || !context_) {
-        std::cerr << "Failed to create OpenCL context." << std::endl;
-        return false;
+    // Keep the dense device copy in sync so training and feedForward see the pruned model
+    cl_int err;
+    size_t weightOffset = 0;
+    for (size_t i = 1; i < layers.size(); i++) {
+        err = clEnqueueWriteBuffer(commandQueue_, weightsBuffer, CL_TRUE,
+                                   weightOffset * sizeof(double),
+                                   layers[i].weights.size() * sizeof(double),
+                                   layers[i].weights.data(), 0, nullptr, nullptr);
+        if (err != CL_SUCCESS) {
+            std::cerr << "Failed to write pruned weights." << std::endl;
+            return false;
+        }
+        weightOffset += layers[i].weights.size();
     }
 
-    commandQueue_ = clCreateCommandQueue(context_, device_, 0, &err);
-    if (err != CL_SUCCESS || !commandQueue_) {
-        std::cerr << "Failed to create OpenCL command queue." << std::endl;
-        return false;
+    return buildSparse();
+}
+
+bool NeuralNetwork::buildSparse() {
+    std::vector<int> rowPtr;
+    std::vector<int> colIdx;
+    std::vector<double> values;
+    rowPtrOffsets.assign(layers.size(), 0);
+
+    // Concatenate the CSR matrices of all layers, row pointers index the shared colIdx/values arrays
+    for (size_t i = 1; i < layers.size(); i++) {
+        int cols = static_cast<int>(layers[i - 1].neurons.size());
+        int rows = static_cast<int>(layers[i].neurons.size());
+        layers[i].sparseWeights = SparseMatrix(layers[i].weights, rows, cols);
+
+        const SparseMatrix &m = layers[i].sparseWeights;
+        int base = static_cast<int>(values.size());
+        rowPtrOffsets[i] = static_cast<int>(rowPtr.size());
+        for (int p: m.rowPtr) rowPtr.push_back(base + p);
+        colIdx.insert(colIdx.end(), m.colIdx.begin(), m.colIdx.end());
+        values.insert(values.end(), m.values.begin(), m.values.end());
     }
-    const std::string kernelCode = read_kernel_file("src/kernelFn.cl");
-    kernelSource = kernelCode.c_str();
 
-    program = clCreateProgramWithSource(context_, 1, &kernelSource, nullptr, &err);
-    if (err != CL_SUCCESS || !program) {
-        std::cerr << "Failed to create OpenCL program." << std::endl;
+    // OpenCL does not allow zero sized buffers
+    if (values.empty()) {
+        colIdx.push_back(0);
+        values.push_back(0.0);
+    }
+
+    if (rowPtrBuffer) clReleaseMemObject(rowPtrBuffer);
+    if (colIdxBuffer) clReleaseMemObject(colIdxBuffer);
+    if (valuesBuffer) clReleaseMemObject(valuesBuffer);
+
+    cl_int err;
+    rowPtrBuffer = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                  rowPtr.size() * sizeof(int), rowPtr.data(), &err);
+    cl_int errCol;
+    colIdxBuffer = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                  colIdx.size() * sizeof(int), colIdx.data(), &errCol);
+    cl_int errVal;
+    valuesBuffer = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                  values.size() * sizeof(double), values.data(), &errVal);
+    if (err != CL_SUCCESS || errCol != CL_SUCCESS || errVal != CL_SUCCESS) {
+        std::cerr << "Failed to create sparse weight buffers." << std::endl;
         return false;
     }
+    return true;
+}
+
+void NeuralNetwork::feedForwardSparse(std::vector<double> &input) {
+    if (!context_ || !commandQueue_) {
+        std::cerr << "OpenCL context or command queue not initialized!" << std::endl;
+        return;
+    }
+    if (!valuesBuffer) {
+        std::cerr << "Sparse weights not built, call prune() first." << std::endl;
+        return;
+    }
+    inputNeurons.resize(layers[0].neurons.size());
+    for (size_t j = 0; j < input.size() && j < inputNeurons.size(); j++) {
+        inputNeurons[j].value = input[j];
+    }
+
+    cl_int err;
+    err = clEnqueueWriteBuffer(commandQueue_, neuronsBuffer, CL_TRUE, 0, inputNeurons.size() * sizeof(Neuron),
+                               inputNeurons.data(), 0,
+                               nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        std::cerr << "Error setting input buffer." << std::endl;
+    }
+
+    err = clSetKernelArg(kernelSparseFF, 0, sizeof(cl_mem), &neuronsBuffer);
+    err |= clSetKernelArg(kernelSparseFF, 1, sizeof(cl_mem), &biasesBuffer);
+    err |= clSetKernelArg(kernelSparseFF, 2, sizeof(cl_mem), &rowPtrBuffer);
+    err |= clSetKernelArg(kernelSparseFF, 3, sizeof(cl_mem), &colIdxBuffer);
+    err |= clSetKernelArg(kernelSparseFF, 4, sizeof(cl_mem), &valuesBuffer);
 
-    err = clBuildProgram(program, 1, &device_, nullptr, nullptr, nullptr);
     if (err != CL_SUCCESS) {
-        std::cerr << "Failed to build OpenCL program." << std::endl;
-        size_t logSize;
-        clGetProgramBuildInfo(program, device_, CL_PROGRAM_BUILD_LOG, 0, nullptr, &logSize);
+        std::cerr << "Error setting kernel sparse FF basic arguments." << std::endl;
+    }
+
+    int offset_prev = 0;
+    int offset_bias = 0;
+    for (int i = 1; i < layers.size(); i++) {
+        int rows = layers[i].neurons.size();
+        int offset_n = offset_prev + layers[i - 1].neurons.size();
+
+        err = clSetKernelArg(kernelSparseFF, 5, sizeof(int), &rows);
+        err |= clSetKernelArg(kernelSparseFF, 6, sizeof(int), &rowPtrOffsets[i]);
+        err |= clSetKernelArg(kernelSparseFF, 7, sizeof(int), &offset_prev);
+        err |= clSetKernelArg(kernelSparseFF, 8, sizeof(int), &offset_n);
+        err |= clSetKernelArg(kernelSparseFF, 9, sizeof(int), &offset_bias);
+        if (err != CL_SUCCESS) {
+            std::cerr << "Error setting kernel sparse FF layer arguments." << std::endl;
+        }
+
+        size_t globalWorkSize = rows;
+        err = clEnqueueNDRangeKernel(commandQueue_, kernelSparseFF, 1, nullptr, &globalWorkSize, nullptr, 0, nullptr,
+                                     nullptr);
+        if (err != CL_SUCCESS) {
+            std::cerr << "Failed to enqueue OpenCL kernel." << std::endl;
+            return;
+        }
 
-        char *log = new char[logSize];
-        clGetProgramBuildInfo(program, device_, CL_PROGRAM_BUILD_LOG, logSize, log, nullptr);
+        offset_prev = offset_n;
+        offset_bias += rows;
+    }
 
-        std::cerr << "Build log:\n" << log << std::endl;
-        delete[] log;
+    // The blocking read waits for the in-order queue to drain
+    err = clEnqueueReadBuffer(commandQueue_, neuronsBuffer, CL_TRUE,
+                              offset_prev * sizeof(double),
+                              layers.back().neurons.size() * sizeof(double),
+                              layers.back().neurons.data(), 0, nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        std::cerr << "Failed to read neuron buffer." << std::endl;
+        return;
+    }
+
+    updateGuess();
+}
+
+void NeuralNetwork::feedForwardSparseCPU(const std::vector<double> &input) {
+    if (layers.size() < 2 || layers.back().sparseWeights.rows == 0) {
+        std::cerr << "Sparse weights not built, call prune() first." << std::endl;
+        return;
+    }
+    for (size_t j = 0; j < input.size() && j < layers[0].neurons.size(); j++) {
+        layers[0].neurons[j].value = input[j];
+    }
+
+    for (size_t i = 1; i < layers.size(); i++) {
+        const SparseMatrix &m = layers[i].sparseWeights;
+        const std::vector<Neuron> &prev = layers[i - 1].neurons;
+        for (int r = 0; r < m.rows; r++) {
+            double sum = 0.0;
+            for (int k = m.rowPtr[r]; k < m.rowPtr[r + 1]; k++) {
+                sum += prev[m.colIdx[k]].value * m.values[k];
+            }
+            sum += layers[i].biasWeights[r];
+            layers[i].neurons[r].value = 1 / (1 + std::exp(-sum));
+        }
+    }
+
+    updateGuess();
+}
+
+bool NeuralNetwork::snapshotParameters(cl_mem weightsDst, cl_mem biasesDst, cl_event *event) {
+    if (!context_ || !commandQueue_) {
+        std::cerr << "OpenCL context or command queue not initialized!" << std::endl;
         return false;
     }
+    // The queue is in-order, so the copy sees the weights after every update enqueued so far
+    cl_event weightsCopied;
+    cl_int err = clEnqueueCopyBuffer(commandQueue_, weightsBuffer, weightsDst, 0, 0, totalWeights * sizeof(double),
+                                     0, nullptr, &weightsCopied);
+    if (err != CL_SUCCESS) {
+        std::cerr << "Failed to snapshot weights." << std::endl;
+        return false;
+    }
+    err = clEnqueueCopyBuffer(commandQueue_, biasesBuffer, biasesDst, 0, 0, totalBiases * sizeof(double),
+                              1, &weightsCopied, event);
+    clReleaseEvent(weightsCopied);
+    if (err != CL_SUCCESS) {
+        std::cerr << "Failed to snapshot biases." << std::endl;
+        return false;
+    }
+    clFlush(commandQueue_);
+    return true;
+}
+
+std::vector<int> NeuralNetwork::topology() const {
+    std::vector<int> topology;
+    for (const Layer &layer: layers) {
+        topology.push_back(layer.neurons.size());
+    }
+    return topology;
+}
+
+size_t NeuralNetwork::denseModelSize() const {
+    return (totalWeights + totalBiases) * sizeof(double);
+}
+
+size_t NeuralNetwork::sparseModelSize() const {
+    size_t size = totalBiases * sizeof(double);
+    for (size_t i = 1; i < layers.size(); i++) {
+        size += layers[i].sparseWeights.sizeInBytes();
+    }
+    return size;
+}
+
+
+bool NeuralNetwork::openCL_init(const std::vector<int> &topology) {
+    cl_int err;
+
+    context_ = runtime_->context();
+    commandQueue_ = runtime_->createQueue();
+    if (!commandQueue_) return false;
 
     neuronsBuffer = createWriteBuffer<Neuron>(totalNeurons);
     weightsBuffer = createWriteBuffer<double>(totalWeights);
@@ -326,17 +581,26 @@ bool NeuralNetwork::openCL_init(const std::vector<int> &topology) {
     topologyBuffer = clCreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
                                     topology.size() * sizeof(int),
                                     const_cast<int *>(topology.data()), &err);
+    if (err != CL_SUCCESS || !topologyBuffer) {
+        std::cerr << "Failed to create topology buffer." << std::endl;
+        return false;
+    }
 
-    kernelFF = clCreateKernel(program, "feed_forward", &err);
+    kernelFF = clCreateKernel(runtime_->program(), "feed_forward", &err);
     if (err != CL_SUCCESS || !kernelFF) {
         std::cerr << "Failed to create OpenCL kernel." << std::endl;
         return false;
     }
-    kernelBP = clCreateKernel(program, "back_propagation", &err);
+    kernelBP = clCreateKernel(runtime_->program(), "back_propagation", &err);
     if (err != CL_SUCCESS || !kernelBP) {
         std::cerr << "Failed to create OpenCL kernel." << std::endl;
         return false;
     }
+    kernelSparseFF = clCreateKernel(runtime_->program(), "feed_forward_sparse", &err);
+    if (err != CL_SUCCESS || !kernelSparseFF) {
+        std::cerr << "Failed to create OpenCL kernel." << std::endl;
+        return false;
+    }
 
     return true;
 }
@@ -344,13 +608,27 @@ bool NeuralNetwork::openCL_init(const std::vector<int> &topology) {
 
 
 NeuralNetwork::~NeuralNetwork() {
-    clReleaseMemObject(neuronsBuffer);
-    clReleaseMemObject(topologyBuffer);
-    clReleaseMemObject(weightsBuffer);
-    clReleaseMemObject(deltasBuffer);
-    clReleaseMemObject(biasesBuffer);
-    clReleaseKernel(kernelBP);
-    clReleaseKernel(kernelFF);
+    release();
+}
+
+void NeuralNetwork::release() {
+    if (neuronsBuffer) clReleaseMemObject(neuronsBuffer);
+    if (topologyBuffer) clReleaseMemObject(topologyBuffer);
+    if (weightsBuffer) clReleaseMemObject(weightsBuffer);
+    if (deltasBuffer) clReleaseMemObject(deltasBuffer);
+    if (biasesBuffer) clReleaseMemObject(biasesBuffer);
+    if (rowPtrBuffer) clReleaseMemObject(rowPtrBuffer);
+    if (colIdxBuffer) clReleaseMemObject(colIdxBuffer);
+    if (valuesBuffer) clReleaseMemObject(valuesBuffer);
+    if (kernelBP) clReleaseKernel(kernelBP);
+    if (kernelFF) clReleaseKernel(kernelFF);
+    if (kernelSparseFF) clReleaseKernel(kernelSparseFF);
+    if (commandQueue_) clReleaseCommandQueue(commandQueue_);
+    neuronsBuffer = topologyBuffer = weightsBuffer = deltasBuffer = biasesBuffer = nullptr;
+    rowPtrBuffer = colIdxBuffer = valuesBuffer = nullptr;
+    kernelBP = kernelFF = kernelSparseFF = nullptr;
+    commandQueue_ = nullptr;
+    context_ = nullptr;
 }
 
 std::vector<double> NeuralNetwork::readCustom() {
@@ -0,0 +1,179 @@
+#include "../inc/ProgramCache.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <iomanip>
+#include <random>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Written in front of every entry so stale or foreign files are never handed to the driver
+static const char *cacheMagic = "neural-clbin-1";
+
+static std::string deviceInfo(cl_device_id device, cl_device_info param) {
+    size_t size = 0;
+    if (clGetDeviceInfo(device, param, 0, nullptr, &size) != CL_SUCCESS || size == 0) return "";
+
+    std::string value(size, '\0');
+    clGetDeviceInfo(device, param, size, value.data(), nullptr);
+    value.resize(value.find('\0') == std::string::npos ? size : value.find('\0'));
+    return value;
+}
+
+ProgramCache::ProgramCache(std::filesystem::path directory) : directory(std::move(directory)) {}
+
+std::filesystem::path ProgramCache::defaultDirectory() {
+    if (const char *env = std::getenv("NEURAL_KERNEL_CACHE")) {
+        return env;
+    }
+    // Per-user locations first, binaries from a shared directory would run on the device unchecked
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return std::filesystem::path{xdg} / "neural";
+    }
+    if (const char *home = std::getenv("HOME"); home && *home) {
+        return std::filesystem::path{home} / ".cache" / "neural";
+    }
+    if (const char *local = std::getenv("LOCALAPPDATA"); local && *local) {
+        return std::filesystem::path{local} / "neural";
+    }
+    std::error_code ec;
+    std::filesystem::path tmp = std::filesystem::temp_directory_path(ec);
+    return (ec ? std::filesystem::path{"."} : tmp) / "neural_kernel_cache";
+}
+
+bool ProgramCache::trustedDirectory(bool create) const {
+    std::error_code ec;
+    bool created = false;
+    if (create) {
+        created = std::filesystem::create_directories(directory, ec);
+        if (ec) return false;
+    }
+    if (!std::filesystem::is_directory(directory, ec)) return false;
+
+    // A directory we just made is private from the start, existing ones are never modified
+    if (created) {
+        std::filesystem::permissions(directory, std::filesystem::perms::owner_all,
+                                     std::filesystem::perm_options::replace, ec);
+        if (ec) return false;
+    }
+
+#ifndef _WIN32
+    // Only use a directory that belongs to us and nobody else can write to
+    struct stat info{};
+    if (stat(directory.c_str(), &info) != 0 || info.st_uid != geteuid() || (info.st_mode & (S_IWGRP | S_IWOTH))) {
+        if (create) {
+            std::cerr << "Kernel cache directory " << directory.string()
+                      << " is not private to this user, skipping the binary cache." << std::endl;
+        }
+        return false;
+    }
+#endif
+    return true;
+}
+
+uint64_t ProgramCache::hash(const std::string &data) {
+    // 64-bit FNV-1a
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c: data) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+std::string ProgramCache::key(cl_device_id device, const std::string &options, const std::string &source) const {
+    std::stringstream key;
+    key << deviceInfo(device, CL_DEVICE_VENDOR) << '|'
+        << deviceInfo(device, CL_DEVICE_NAME) << '|'
+        << deviceInfo(device, CL_DEVICE_VERSION) << '|'
+        << deviceInfo(device, CL_DRIVER_VERSION) << '|'
+        << options << '|'
+        << std::hex << std::setw(16) << std::setfill('0') << hash(source);
+
+    // The key is stored as the first line of the entry
+    std::string value = key.str();
+    for (char &c: value) {
+        if (c == '\n' || c == '\r') c = ' ';
+    }
+    return value;
+}
+
+std::filesystem::path ProgramCache::entryPath(const std::string &key) const {
+    std::stringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hash(key) << ".clbin";
+    return directory / name.str();
+}
+
+cl_program ProgramCache::load(cl_context context, cl_device_id device, const std::string &key,
+                              const std::string &options) const {
+    if (!trustedDirectory(false)) return nullptr;
+
+    std::ifstream file(entryPath(key), std::ios::binary);
+    if (!file.is_open()) return nullptr;
+
+    std::string magic, storedKey;
+    if (!std::getline(file, magic) || magic != cacheMagic) return nullptr;
+    if (!std::getline(file, storedKey) || storedKey != key) return nullptr;
+
+    std::vector<unsigned char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (binary.empty()) return nullptr;
+
+    cl_int err, binaryStatus;
+    size_t size = binary.size();
+    const unsigned char *data = binary.data();
+    cl_program program = clCreateProgramWithBinary(context, 1, &device, &size, &data, &binaryStatus, &err);
+    if (err != CL_SUCCESS || binaryStatus != CL_SUCCESS || !program) {
+        if (program) clReleaseProgram(program);
+        return nullptr;
+    }
+
+    // Binaries still need a build call, which only links and is cheap compared to compiling source
+    err = clBuildProgram(program, 1, &device, options.c_str(), nullptr, nullptr);
+    if (err != CL_SUCCESS) {
+        clReleaseProgram(program);
+        return nullptr;
+    }
+    return program;
+}
+
+bool ProgramCache::store(cl_program program, const std::string &key) const {
+    size_t size = 0;
+    cl_int err = clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &size, nullptr);
+    if (err != CL_SUCCESS || size == 0) return false;
+
+    std::vector<unsigned char> binary(size);
+    unsigned char *data = binary.data();
+    err = clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(unsigned char *), &data, nullptr);
+    if (err != CL_SUCCESS) return false;
+
+    if (!trustedDirectory(true)) return false;
+
+    // Write to a file of our own next to the entry and rename, so a concurrent start never reads
+    // a half written binary and two cold starts never write the same temporary file
+    std::stringstream suffix;
+    suffix << "." << std::hex << std::random_device{}() << ".tmp";
+    std::filesystem::path path = entryPath(key);
+    std::filesystem::path tmp = path;
+    tmp += suffix.str();
+    std::error_code ec;
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        file << cacheMagic << '\n' << key << '\n';
+        file.write(reinterpret_cast<const char *>(binary.data()), binary.size());
+    }
+    if (std::filesystem::file_size(tmp, ec) != binary.size() + std::strlen(cacheMagic) + key.size() + 2) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
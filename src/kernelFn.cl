@@ -86,6 +86,36 @@ __kernel void feed_forward(
 }
 
 
+__kernel void feed_forward_sparse(
+        __global struct Neuron *neurons,     // all neurons of the network
+        __global double *biasWeights,       // weights for biases
+        __global int *rowPtr,              // CSR row pointers of all layers
+        __global int *colIdx,              // CSR column indices of all layers
+        __global double *values,           // CSR non-zero weights of all layers
+        int rows,                          // neurons in the current layer
+        int row_offset,                    // first rowPtr entry of the current layer
+        int neuron_offset_prev,            // first neuron of the previous layer
+        int neuron_offset,                 // first neuron of the current layer
+        int bias_offset                    // first bias of the current layer
+) {
+    int id = get_global_id(0);
+    if (id >= rows) return;
+
+    double sum = 0.0;
+    int start = rowPtr[row_offset + id];
+    int end = rowPtr[row_offset + id + 1];
+
+    // Only the weights that survived pruning contribute
+    for (int k = start; k < end; k++) {
+        sum += neurons[neuron_offset_prev + colIdx[k]].value * values[k];
+    }
+
+    sum += biasWeights[bias_offset + id];
+
+    neurons[neuron_offset + id].value = 1 / (1 + exp(-sum));
+}
+
+
 __kernel void init(
         __global double *weights,        // Buffer of weights
         __global double *biases,         // Buffer of biases